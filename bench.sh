@@ -0,0 +1,52 @@
+#!/bin/sh
+# time next/list/block on a generated task file at several thread counts.
+#
+#   ./bench.sh [tasks] [thread counts...]
+#   ./bench.sh 1000000 1 2 4 8 16 32
+#
+# each run is repeated three times and the fastest --print-timing total is kept.
+set -e
+
+BIN=${BIN:-./task-dag}
+TASKS=${1:-500000}
+[ $# -gt 0 ] && shift
+THREADS=${*:-1 2 4 8 16 32}
+FILE=${TMPDIR:-/tmp}/task-dag-bench.$$.dag
+
+trap 'rm -f "$FILE"' EXIT
+
+# every task depends on up to three earlier ones; about a third are done
+awk -v n="$TASKS" 'BEGIN {
+	srand(1)
+	for (i = 0; i < n; i++) {
+		line = (rand() < 0.33 ? "[x]" : "[ ]") " task " i
+		if (i % 7 == 0)
+			line = line " !high"
+		deps = ""
+		for (d = 0; d < 3 && i > 0; d++) {
+			if (rand() < 0.5)
+				deps = deps (deps == "" ? "" : ", ") "task " int(rand() * i)
+		}
+		if (deps != "")
+			line = line " -> " deps
+		print line
+	}
+}' > "$FILE"
+
+echo "$TASKS tasks, $(wc -c < "$FILE") bytes, $(getconf _NPROCESSORS_ONLN 2>/dev/null || echo '?') cpus"
+printf '%-8s %-12s %s\n' threads command "best total (us)"
+
+for t in $THREADS; do
+	for cmd in next "list --count" "block --count"; do
+		best=
+		for run in 1 2 3; do
+			# shellcheck disable=SC2086
+			us=$(TASKDAG_THREADS=$t "$BIN" "$FILE" $cmd --print-timing 2>&1 >/dev/null |
+				sed -n 's/^timing: .*total \([0-9]*\)us$/\1/p')
+			if [ -z "$best" ] || [ "$us" -lt "$best" ]; then
+				best=$us
+			fi
+		done
+		printf '%-8s %-12s %s\n' "$t" "$cmd" "$best"
+	done
+done
@@ -1,14 +1,16 @@
 #include "commands.hpp"
 
 #include "config.hpp"
+#include "filter.hpp"
+#include "history.hpp"
 #include "task.hpp"
 #include "util.hpp"
 
 #include <cstdlib>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <string>
+#include <sys/stat.h>
 #include <vector>
 
 void usage(const char* prog) {
@@ -17,12 +19,32 @@ void usage(const char* prog) {
 		  << "  next      show actionable tasks (default)\n"
 		  << "  list      show all tasks\n"
 		  << "  add       add a new task\n"
+		  << "  start     record that a task was started (reads name from stdin)\n"
 		  << "  complete  mark task complete (reads name from stdin)\n"
 		  << "  done      complete the task if only one actionable task exists\n"
 		  << "  block     show blocking dependencies\n"
+		  << "  levels    show topological layers and how many tasks can run in parallel\n"
+		  << "  simulate  estimate how long the remaining tasks take with N workers\n"
+		  << "  stats     show wait and work time percentiles from the history log\n"
+		  << "  diff      show what became actionable or blocked between two files: diff OLD NEW\n"
 		  << "  graph     output DOT format\n"
 		  << "  edit      open task file in editor\n"
 		  << "  help      show this help\n\n"
+		  << "options for next, list and block:\n"
+		  << "  --where EXPR  only show tasks matching EXPR, e.g. 'priority>=high and name~deploy'\n"
+		  << "  --tag TAG     only show tasks tagged #TAG (or annotated key:value); repeatable\n"
+		  << "  --count       print the number of matching tasks instead of the tasks\n"
+		  << "  --stream      next only: one pass keeping only pending tasks, without validation\n\n"
+		  << "options for levels:\n"
+		  << "  --unfinished  ignore completed tasks\n"
+		  << "  --summary     print only the width histogram\n\n"
+		  << "options for simulate:\n"
+		  << "  --workers N     number of workers (default 1)\n"
+		  << "  --default DUR   duration of tasks without an est: annotation or history (default 1h)\n\n"
+		  << "options for stats:\n"
+		  << "  --by priority|tag|task  how to group the percentiles (default priority)\n\n"
+		  << "global options:\n"
+		  << "  --print-timing  report time spent in each startup phase on stderr\n\n"
 		  << "file defaults to ~/.local/share/task-dag/tasks.dag or $TASKDAG_FILE\n";
 }
 
@@ -34,24 +56,29 @@ std::string find_file(const std::string& hint) {
 	if (env)
 		return env;
 
+	/* one stat() per candidate; nothing is opened or created until a file is chosen */
+	auto is_file = [](const std::string& path) {
+		struct stat st;
+		return ::stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode);
+	};
+
 	/* check data directory first */
 	std::string data_dir = get_data_dir();
-	std::filesystem::create_directories(data_dir);
-
 	const char* names[] = {"tasks.dag", "tasks.txt", "todo.dag", "todo.txt"};
 	for (const char* name : names) {
 		std::string path = data_dir + "/" + name;
-		std::ifstream f(path);
-		if (f)
+		if (is_file(path))
 			return path;
 	}
 
 	for (const char* name : names) {
-		std::ifstream f(name);
-		if (f)
+		if (is_file(name))
 			return name;
 	}
 
+	/* fall back to a new file in the data directory, which may not exist yet */
+	std::error_code ec;
+	std::filesystem::create_directories(data_dir, ec);
 	return data_dir + "/tasks.dag";
 }
 
@@ -68,14 +95,86 @@ static std::string priority_to_string(Priority p) {
 	}
 }
 
+/* parse --where / --tag / --count / --stream for the query commands (next, list, block) */
+static bool parse_query_args(const std::vector<std::string>& args, Filter& filter, bool& filtered, bool& count,
+			     bool& stream) {
+	for (size_t i = 0; i < args.size(); i++) {
+		if (args[i] == "--where") {
+			if (i + 1 >= args.size()) {
+				std::cerr << "error: --where requires an expression\n";
+				return false;
+			}
+			if (!filter.compile(args[++i]))
+				return false;
+			filtered = true;
+		} else if (args[i] == "--tag") {
+			if (i + 1 >= args.size()) {
+				std::cerr << "error: --tag requires a value\n";
+				return false;
+			}
+			std::string tag = args[++i];
+			if (!tag.empty() && tag[0] == '#')
+				tag = tag.substr(1);
+			filter.tags.push_back(tag);
+			filtered = true;
+		} else if (args[i] == "--count") {
+			count = true;
+		} else if (args[i] == "--stream") {
+			stream = true;
+		} else {
+			std::cerr << "error: unexpected argument '" << args[i] << "'\n";
+			return false;
+		}
+	}
+	return true;
+}
+
 int run_command(TaskFile& tf, const std::string& command, const Config& config, const std::string& filepath,
 		const std::vector<std::string>& args) {
-	if (command == "next") {
-		for (const auto& name : tf.get_next()) {
-			std::cout << name << "\n";
+	/* these take no options, so anything main passed along is a mistake */
+	bool no_options = command == "graph" || command == "edit" || command == "done" || command == "complete" ||
+			  command == "start";
+	if (no_options && !args.empty()) {
+		std::cerr << "error: unexpected argument '" << args[0] << "'\n";
+		return 1;
+	}
+
+	if (command == "next" || command == "list" || command == "block") {
+		Filter filter;
+		bool filtered = false, count = false, stream = false;
+		if (!parse_query_args(args, filter, filtered, count, stream))
+			return 1;
+		const Filter* f = filtered ? &filter : nullptr;
+
+		if (stream) {
+			/* main skips loading for next --stream; tf is empty here */
+			if (command != "next" || filtered) {
+				std::cerr << "error: --stream only applies to next, without --where or --tag\n";
+				return 1;
+			}
+			std::vector<std::string> actionable;
+			if (!stream_next(filepath, actionable))
+				return 1;
+			if (count) {
+				std::cout << actionable.size() << "\n";
+			} else {
+				for (const auto& name : actionable) {
+					std::cout << name << "\n";
+				}
+			}
+		} else if (command == "next") {
+			if (count) {
+				std::cout << tf.count_next(f) << "\n";
+			} else {
+				for (const auto& name : tf.get_next(f)) {
+					std::cout << name << "\n";
+				}
+			}
+		} else if (command == "list") {
+			tf.print_list(f, count);
+		} else {
+			tf.print_blocked(f, count);
 		}
-	} else if (command == "list") {
-		tf.print_list();
 	} else if (command == "done") {
 		std::vector<std::string> actionable = tf.get_next();
 		if (actionable.empty()) {
@@ -85,6 +184,7 @@ int run_command(TaskFile& tf, const std::string& command, const Config& config,
 			std::string task_name = actionable[0];
 			if (!tf.complete(task_name))
 				return 1;
+			record_completion(tf, task_name);
 			std::cout << "completed: " << task_name << "\n";
 		} else {
 			std::cerr << "multiple actionable tasks:\n";
@@ -106,11 +206,113 @@ int run_command(TaskFile& tf, const std::string& command, const Config& config,
 			return 1;
 		}
 		task_name = trim(task_name);
+		/* completing a done task again only warns; don't log a second completion for it */
+		bool was_done = tf.tasks.count(task_name) && tf.get_task(task_name).completed;
 		if (!tf.complete(task_name))
 			return 1;
+		if (!was_done)
+			record_completion(tf, task_name);
 		std::cout << "completed: " << task_name << "\n";
-	} else if (command == "block") {
-		tf.print_blocked();
+	} else if (command == "start") {
+		std::string task_name;
+		if (!std::getline(std::cin, task_name)) {
+			std::cerr << "error: no task name provided\n";
+			return 1;
+		}
+		task_name = trim(task_name);
+		if (!tf.tasks.count(task_name)) {
+			std::cerr << "error: unknown task '" << task_name << "'\n";
+			return 1;
+		}
+		const Task& task = tf.get_task(task_name);
+		if (task.completed) {
+			std::cerr << "error: task '" << task_name << "' already completed\n";
+			return 1;
+		}
+		for (const auto& dep : task.deps) {
+			if (!tf.get_task(dep).completed) {
+				std::cerr << "error: task '" << task_name << "' is blocked by '" << dep << "'\n";
+				return 1;
+			}
+		}
+		record_start(tf, task_name);
+		std::cout << "started: " << task_name << "\n";
+	} else if (command == "stats") {
+		std::string by = "priority";
+		for (size_t i = 0; i < args.size(); i++) {
+			if (args[i] == "--by") {
+				if (i + 1 >= args.size()) {
+					std::cerr << "error: --by requires a value\n";
+					return 1;
+				}
+				by = args[++i];
+				if (by != "priority" && by != "tag" && by != "task") {
+					std::cerr << "error: invalid grouping '" << by
+						  << "', must be priority|tag|task\n";
+					return 1;
+				}
+			} else {
+				std::cerr << "error: unexpected argument '" << args[i] << "'\n";
+				return 1;
+			}
+		}
+		print_stats(tf, by);
+	} else if (command == "levels") {
+		bool unfinished = false, summary = false;
+		for (const auto& arg : args) {
+			if (arg == "--unfinished") {
+				unfinished = true;
+			} else if (arg == "--summary") {
+				summary = true;
+			} else {
+				std::cerr << "error: unexpected argument '" << arg << "'\n";
+				return 1;
+			}
+		}
+		tf.print_levels(unfinished, summary);
+	} else if (command == "simulate") {
+		int workers = 1;
+		double default_duration = 3600;
+		for (size_t i = 0; i < args.size(); i++) {
+			if (args[i] == "--workers") {
+				if (i + 1 >= args.size()) {
+					std::cerr << "error: --workers requires a value\n";
+					return 1;
+				}
+				std::string value = args[++i];
+				char* end;
+				long n = std::strtol(value.c_str(), &end, 10);
+				if (value.empty() || *end != '\0' || n < 1 || n > 1000000) {
+					std::cerr << "error: invalid worker count '" << value << "'\n";
+					return 1;
+				}
+				workers = static_cast<int>(n);
+			} else if (args[i] == "--default") {
+				if (i + 1 >= args.size()) {
+					std::cerr << "error: --default requires a duration\n";
+					return 1;
+				}
+				if (!parse_duration(args[++i], default_duration)) {
+					std::cerr << "error: invalid duration '" << args[i] << "'\n";
+					return 1;
+				}
+			} else {
+				std::cerr << "error: unexpected argument '" << args[i] << "'\n";
+				return 1;
+			}
+		}
+		tf.print_simulation(workers, default_duration, observed_durations(tf));
+	} else if (command == "diff") {
+		if (args.size() != 2) {
+			std::cerr << "usage: task-dag diff OLD NEW\n";
+			return 1;
+		}
+		TaskFile before, after;
+		if (!before.load(args[0]) || !before.validate())
+			return 1;
+		if (!after.load(args[1]) || !after.validate())
+			return 1;
+		print_diff(before, after);
 	} else if (command == "graph") {
 		tf.print_graph(config);
 	} else if (command == "edit") {
@@ -0,0 +1,328 @@
+#include "filter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Pred = std::function<bool(const Task&, int)>;
+
+enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Match, NoMatch };
+
+struct Token {
+	enum Kind { Word, Oper, LParen, RParen, End } kind;
+	std::string text;
+};
+
+static bool is_op_char(char c) {
+	return c == '=' || c == '!' || c == '<' || c == '>' || c == '~';
+}
+
+static bool tokenize(const std::string& expr, std::vector<Token>& toks) {
+	size_t i = 0;
+	while (i < expr.size()) {
+		char c = expr[i];
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			i++;
+		} else if (c == '(') {
+			toks.push_back({Token::LParen, "("});
+			i++;
+		} else if (c == ')') {
+			toks.push_back({Token::RParen, ")"});
+			i++;
+		} else if (c == '"' || c == '\'') {
+			size_t end = expr.find(c, i + 1);
+			if (end == std::string::npos) {
+				std::cerr << "error: --where: unterminated quote\n";
+				return false;
+			}
+			toks.push_back({Token::Word, expr.substr(i + 1, end - i - 1)});
+			i = end + 1;
+		} else if (is_op_char(c)) {
+			size_t start = i;
+			while (i < expr.size() && is_op_char(expr[i]))
+				i++;
+			toks.push_back({Token::Oper, expr.substr(start, i - start)});
+		} else {
+			size_t start = i;
+			while (i < expr.size() && !std::isspace(static_cast<unsigned char>(expr[i])) &&
+			       !is_op_char(expr[i]) && expr[i] != '(' && expr[i] != ')')
+				i++;
+			toks.push_back({Token::Word, expr.substr(start, i - start)});
+		}
+	}
+	toks.push_back({Token::End, ""});
+	return true;
+}
+
+static bool parse_op(const std::string& s, Op& op) {
+	if (s == "=" || s == "==")
+		op = Op::Eq;
+	else if (s == "!=")
+		op = Op::Ne;
+	else if (s == "<")
+		op = Op::Lt;
+	else if (s == "<=")
+		op = Op::Le;
+	else if (s == ">")
+		op = Op::Gt;
+	else if (s == ">=")
+		op = Op::Ge;
+	else if (s == "~")
+		op = Op::Match;
+	else if (s == "!~")
+		op = Op::NoMatch;
+	else
+		return false;
+	return true;
+}
+
+static bool compare(int a, Op op, int b) {
+	switch (op) {
+		case Op::Eq:
+			return a == b;
+		case Op::Ne:
+			return a != b;
+		case Op::Lt:
+			return a < b;
+		case Op::Le:
+			return a <= b;
+		case Op::Gt:
+			return a > b;
+		case Op::Ge:
+			return a >= b;
+		default:
+			return false;
+	}
+}
+
+static bool parse_priority(const std::string& s, Priority& p) {
+	if (s == "high" || s == "h")
+		p = Priority::High;
+	else if (s == "med" || s == "m" || s == "medium")
+		p = Priority::Med;
+	else if (s == "low" || s == "l")
+		p = Priority::Low;
+	else
+		return false;
+	return true;
+}
+
+static bool parse_int(const std::string& s, int& out) {
+	if (s.empty())
+		return false;
+	size_t i = (s[0] == '-') ? 1 : 0;
+	if (i == s.size() || s.size() - i > 9)
+		return false;
+	for (size_t j = i; j < s.size(); j++) {
+		if (!std::isdigit(static_cast<unsigned char>(s[j])))
+			return false;
+	}
+	out = std::stoi(s);
+	return true;
+}
+
+struct FilterParser {
+	std::vector<Token> toks;
+	size_t pos = 0;
+	bool uses_depth = false;
+	bool ok = true;
+
+	const Token& peek() const {
+		return toks[pos];
+	}
+
+	bool accept_word(const char* word) {
+		if (peek().kind == Token::Word && peek().text == word) {
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	Pred fail(const std::string& msg) {
+		if (ok)
+			std::cerr << "error: --where: " << msg << "\n";
+		ok = false;
+		return nullptr;
+	}
+
+	Pred parse_or() {
+		Pred lhs = parse_and();
+		while (ok && accept_word("or")) {
+			Pred rhs = parse_and();
+			lhs = [lhs, rhs](const Task& t, int d) { return lhs(t, d) || rhs(t, d); };
+		}
+		return lhs;
+	}
+
+	Pred parse_and() {
+		Pred lhs = parse_unary();
+		while (ok && accept_word("and")) {
+			Pred rhs = parse_unary();
+			lhs = [lhs, rhs](const Task& t, int d) { return lhs(t, d) && rhs(t, d); };
+		}
+		return lhs;
+	}
+
+	Pred parse_unary() {
+		if (!ok)
+			return nullptr;
+		if (accept_word("not")) {
+			Pred inner = parse_unary();
+			return [inner](const Task& t, int d) { return !inner(t, d); };
+		}
+		if (peek().kind == Token::LParen) {
+			pos++;
+			Pred inner = parse_or();
+			if (!ok)
+				return nullptr;
+			if (peek().kind != Token::RParen)
+				return fail("expected ')'");
+			pos++;
+			return inner;
+		}
+		return parse_comparison();
+	}
+
+	Pred parse_comparison() {
+		if (peek().kind != Token::Word)
+			return fail("expected field name");
+		std::string field = toks[pos++].text;
+
+		Op op;
+		if (peek().kind != Token::Oper || !parse_op(peek().text, op))
+			return fail("expected operator after '" + field + "'");
+		std::string op_text = toks[pos++].text;
+
+		if (peek().kind != Token::Word)
+			return fail("expected value after '" + field + op_text + "'");
+		std::string value = toks[pos++].text;
+
+		if (field == "name") {
+			switch (op) {
+				case Op::Eq:
+					return [value](const Task& t, int) { return t.name == value; };
+				case Op::Ne:
+					return [value](const Task& t, int) { return t.name != value; };
+				case Op::Match:
+					return [value](const Task& t, int) {
+						return t.name.find(value) != std::string::npos;
+					};
+				case Op::NoMatch:
+					return [value](const Task& t, int) {
+						return t.name.find(value) == std::string::npos;
+					};
+				default:
+					return fail("'name' supports =, !=, ~ and !~");
+			}
+		}
+
+		bool builtin = field == "priority" || field == "status" || field == "depth" || field == "line" ||
+			       field == "deps" || field == "tag";
+		if (builtin && (op == Op::Match || op == Op::NoMatch))
+			return fail("'" + field + "' does not support ~");
+
+		if (field == "priority") {
+			Priority p;
+			if (!parse_priority(value, p))
+				return fail("invalid priority '" + value + "', must be high|med|low");
+			int rank = static_cast<int>(p);
+			return [op, rank](const Task& t, int) {
+				return compare(static_cast<int>(t.priority), op, rank);
+			};
+		}
+
+		if (field == "status") {
+			if (op != Op::Eq && op != Op::Ne)
+				return fail("'status' supports = and !=");
+			bool want_done;
+			if (value == "done")
+				want_done = true;
+			else if (value == "pending")
+				want_done = false;
+			else
+				return fail("invalid status '" + value + "', must be done|pending");
+			bool eq = (op == Op::Eq);
+			return [want_done, eq](const Task& t, int) { return (t.completed == want_done) == eq; };
+		}
+
+		if (field == "depth" || field == "line" || field == "deps") {
+			int n;
+			if (!parse_int(value, n))
+				return fail("'" + field + "' expects an integer, got '" + value + "'");
+			if (field == "depth") {
+				uses_depth = true;
+				return [op, n](const Task&, int d) { return compare(d, op, n); };
+			}
+			if (field == "line")
+				return [op, n](const Task& t, int) { return compare(t.line_num, op, n); };
+			return [op, n](const Task& t, int) { return compare(static_cast<int>(t.deps.size()), op, n); };
+		}
+
+		if (field == "tag") {
+			if (op != Op::Eq && op != Op::Ne)
+				return fail("'tag' supports = and !=");
+			std::string tag = (!value.empty() && value[0] == '#') ? value.substr(1) : value;
+			bool eq = (op == Op::Eq);
+			return [tag, eq](const Task& t, int) {
+				bool has = std::find(t.tags.begin(), t.tags.end(), tag) != t.tags.end();
+				return has == eq;
+			};
+		}
+
+		if (field.size() < 2 || field[0] != '@')
+			return fail("unknown field '" + field + "'");
+
+		/* "@key" names a key:value annotation; a missing key only matches != */
+		std::string key = field.substr(1);
+		int n = 0;
+		bool numeric = op != Op::Match && op != Op::NoMatch && parse_int(value, n);
+		return [key, op, value, numeric, n](const Task& t, int) {
+			auto it = t.annotations.find(key);
+			if (it == t.annotations.end())
+				return op == Op::Ne || op == Op::NoMatch;
+			const std::string& have = it->second;
+			int m;
+			if (numeric && parse_int(have, m))
+				return compare(m, op, n);
+			switch (op) {
+				case Op::Eq:
+					return have == value;
+				case Op::Ne:
+					return have != value;
+				case Op::Match:
+					return have.find(value) != std::string::npos;
+				case Op::NoMatch:
+					return have.find(value) == std::string::npos;
+				default:
+					return compare(have.compare(value), op, 0);
+			}
+		};
+	}
+};
+
+bool Filter::compile(const std::string& expr) {
+	FilterParser p;
+	if (!tokenize(expr, p.toks))
+		return false;
+	if (p.peek().kind == Token::End) {
+		std::cerr << "error: --where: empty expression\n";
+		return false;
+	}
+
+	Pred compiled = p.parse_or();
+	if (p.ok && p.peek().kind != Token::End)
+		p.fail("unexpected '" + p.peek().text + "'");
+	if (!p.ok)
+		return false;
+
+	pred = compiled;
+	uses_depth = p.uses_depth;
+	return true;
+}
+
+bool Filter::matches(const Task& task, int depth) const {
+	return !pred || pred(task, depth);
+}
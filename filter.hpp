@@ -0,0 +1,22 @@
+#pragma once
+
+#include "task.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * a --where expression compiled into a predicate, e.g.
+ *   priority>=high and name~deploy and depth<3
+ * plus any --tag restrictions, which are answered from the tag index
+ * rather than by matches().
+ */
+struct Filter {
+	std::function<bool(const Task&, int)> pred;
+	bool uses_depth = false;
+	std::vector<std::string> tags;
+
+	bool compile(const std::string& expr);
+	bool matches(const Task& task, int depth) const;
+};
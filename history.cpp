@@ -0,0 +1,276 @@
+#include "history.hpp"
+
+#include "config.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+static const char history_magic[4] = {'T', 'D', 'H', '2'};
+
+std::string get_history_path() {
+	return get_data_dir() + "/history.bin";
+}
+
+/* FNV-1a of the canonical path, so "./todo.md" and "/home/me/todo.md" agree */
+uint64_t history_file_id(const std::string& path) {
+	std::error_code ec;
+	std::string canonical = std::filesystem::weakly_canonical(path, ec).string();
+	if (ec)
+		canonical = path;
+	uint64_t h = 14695981039346656037ull;
+	for (unsigned char c : canonical) {
+		h ^= c;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+bool append_history(const std::vector<HistoryRecord>& records) {
+	std::string path = get_history_path();
+	std::error_code ec;
+	std::filesystem::create_directories(get_data_dir(), ec);
+
+	/* never append records to a log written in another format */
+	std::ifstream existing(path, std::ios::binary);
+	char magic[sizeof(history_magic)];
+	if (existing.read(magic, sizeof(magic)) && !std::equal(magic, magic + sizeof(magic), history_magic)) {
+		std::cerr << "warning: " << path << " is not a task-dag history file, not recording\n";
+		return false;
+	}
+	existing.close();
+
+	std::ofstream f(path, std::ios::binary | std::ios::app);
+	if (!f) {
+		std::cerr << "warning: cannot write history to " << path << "\n";
+		return false;
+	}
+	if (f.tellp() == 0)
+		f.write(history_magic, sizeof(history_magic));
+
+	for (const auto& r : records) {
+		if (r.name.size() > UINT16_MAX)
+			continue;
+		uint8_t event = static_cast<uint8_t>(r.event);
+		uint8_t priority = static_cast<uint8_t>(r.priority);
+		uint16_t len = static_cast<uint16_t>(r.name.size());
+		f.write(reinterpret_cast<const char*>(&r.time), sizeof(r.time));
+		f.write(reinterpret_cast<const char*>(&r.file), sizeof(r.file));
+		f.write(reinterpret_cast<const char*>(&event), sizeof(event));
+		f.write(reinterpret_cast<const char*>(&priority), sizeof(priority));
+		f.write(reinterpret_cast<const char*>(&len), sizeof(len));
+		f.write(r.name.data(), len);
+	}
+	return static_cast<bool>(f);
+}
+
+bool read_history(const std::function<void(const HistoryRecord&)>& visit) {
+	std::ifstream f(get_history_path(), std::ios::binary);
+	if (!f)
+		return false;
+
+	char magic[sizeof(history_magic)];
+	if (!f.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), history_magic)) {
+		std::cerr << "warning: " << get_history_path() << " is not a task-dag history file\n";
+		return false;
+	}
+
+	HistoryRecord r;
+	uint8_t event, priority;
+	uint16_t len;
+	while (f.read(reinterpret_cast<char*>(&r.time), sizeof(r.time))) {
+		f.read(reinterpret_cast<char*>(&r.file), sizeof(r.file));
+		f.read(reinterpret_cast<char*>(&event), sizeof(event));
+		f.read(reinterpret_cast<char*>(&priority), sizeof(priority));
+		f.read(reinterpret_cast<char*>(&len), sizeof(len));
+		r.name.resize(len);
+		if (!f.read(&r.name[0], len) || event > 2 || priority > 2) {
+			std::cerr << "warning: history ends in a truncated or corrupt record\n";
+			break;
+		}
+		r.event = static_cast<HistoryEvent>(event);
+		r.priority = static_cast<Priority>(priority);
+		visit(r);
+	}
+	return true;
+}
+
+void record_start(const TaskFile& tf, const std::string& name) {
+	const Task& task = tf.get_task(name);
+	append_history({{std::time(nullptr), history_file_id(tf.path), HistoryEvent::Start, task.priority, name}});
+}
+
+void record_completion(const TaskFile& tf, const std::string& name) {
+	const Task& task = tf.get_task(name);
+	int64_t now = std::time(nullptr);
+	uint64_t file = history_file_id(tf.path);
+	std::vector<HistoryRecord> records = {{now, file, HistoryEvent::Complete, task.priority, name}};
+
+	/* dependents whose last pending dep was this task are now actionable */
+	const TaskColumns& cols = tf.cols;
+	for (size_t id = 0; id < tf.by_id.size(); id++) {
+		if (cols.done[id])
+			continue;
+		auto first = cols.dep_ids.begin() + cols.dep_offset[id];
+		auto last = cols.dep_ids.begin() + cols.dep_offset[id + 1];
+		if (std::find(first, last, task.id) == last)
+			continue;
+		if (std::all_of(first, last, [&](uint32_t dep) { return cols.done[dep]; }))
+			records.push_back({now, file, HistoryEvent::Ready, tf.by_id[id]->priority, tf.by_id[id]->name});
+	}
+
+	append_history(records);
+}
+
+std::unordered_map<std::string, double> observed_durations(const TaskFile& tf) {
+	uint64_t file = history_file_id(tf.path);
+	std::unordered_map<std::string, int64_t> started;
+	std::unordered_map<std::string, std::pair<double, int>> sums;
+	read_history([&](const HistoryRecord& r) {
+		if (r.file != file)
+			return;
+		if (r.event == HistoryEvent::Start) {
+			started[r.name] = r.time;
+		} else if (r.event == HistoryEvent::Complete) {
+			auto it = started.find(r.name);
+			if (it == started.end())
+				return;
+			auto& s = sums[r.name];
+			s.first += static_cast<double>(r.time - it->second);
+			s.second++;
+			started.erase(it);
+		}
+	});
+
+	std::unordered_map<std::string, double> mean;
+	for (const auto& pair : sums)
+		mean[pair.first] = pair.second.first / pair.second.second;
+	return mean;
+}
+
+/*
+ * log-bucketed quantile sketch: every value lands in a bucket whose bounds are within 1% of it, so
+ * memory depends on the range of durations (a few hundred buckets), not on how many were added.
+ */
+struct Sketch {
+	std::map<int, uint64_t> buckets;
+	uint64_t zeros = 0;
+	uint64_t count = 0;
+
+	static double gamma() {
+		return 1.01 / 0.99;
+	}
+
+	void add(double v) {
+		count++;
+		if (v < 1) {
+			zeros++;
+			return;
+		}
+		buckets[static_cast<int>(std::ceil(std::log(v) / std::log(gamma())))]++;
+	}
+
+	double quantile(double q) const {
+		double rank = q * (count - 1);
+		uint64_t seen = zeros;
+		if (rank < seen)
+			return 0;
+		for (const auto& b : buckets) {
+			seen += b.second;
+			if (rank < seen)
+				return 2 * std::pow(gamma(), b.first) / (gamma() + 1);
+		}
+		return 0;
+	}
+};
+
+struct GroupStats {
+	Sketch wait; /* ready -> start */
+	Sketch work; /* start -> complete */
+	Sketch lead; /* ready -> complete */
+};
+
+static std::string priority_name(Priority p) {
+	switch (p) {
+		case Priority::High:
+			return "high";
+		case Priority::Low:
+			return "low";
+		default:
+			return "med";
+	}
+}
+
+void print_stats(const TaskFile& tf, const std::string& by) {
+	struct Pending {
+		int64_t ready = -1;
+		int64_t start = -1;
+	};
+	std::unordered_map<std::string, Pending> in_flight;
+	std::map<std::string, GroupStats> groups;
+
+	auto group_keys = [&](const HistoryRecord& r) {
+		if (by == "task")
+			return std::vector<std::string>{r.name};
+		if (by == "priority")
+			return std::vector<std::string>{priority_name(r.priority)};
+		/* tags come from the current file; tasks since removed from it are untagged */
+		auto it = tf.tasks.find(r.name);
+		if (it == tf.tasks.end() || it->second.tags.empty())
+			return std::vector<std::string>{"(untagged)"};
+		return it->second.tags;
+	};
+
+	uint64_t file = history_file_id(tf.path);
+	bool found = read_history([&](const HistoryRecord& r) {
+		if (r.file != file)
+			return;
+		Pending& p = in_flight[r.name];
+		if (r.event == HistoryEvent::Ready) {
+			p.ready = r.time;
+		} else if (r.event == HistoryEvent::Start) {
+			/*
+			 * Ready is only logged when a completion unblocks a task, so root tasks and tasks
+			 * added or edited into a ready state count as ready when started: their wait is zero.
+			 */
+			if (p.ready < 0)
+				p.ready = r.time;
+			p.start = r.time;
+		} else {
+			for (const auto& key : group_keys(r)) {
+				GroupStats& g = groups[key];
+				if (p.ready >= 0 && p.start >= p.ready)
+					g.wait.add(static_cast<double>(p.start - p.ready));
+				if (p.start >= 0)
+					g.work.add(static_cast<double>(r.time - p.start));
+				if (p.ready >= 0)
+					g.lead.add(static_cast<double>(r.time - p.ready));
+			}
+			in_flight.erase(r.name);
+		}
+	});
+
+	if (!found || groups.empty()) {
+		std::cout << "no completed tasks in history\n";
+		return;
+	}
+
+	std::cout << by << "\tmetric\tn\tp50\tp90\tp99\n";
+	for (const auto& pair : groups) {
+		const std::pair<const char*, const Sketch*> metrics[] = {
+		    {"wait", &pair.second.wait}, {"work", &pair.second.work}, {"lead", &pair.second.lead}};
+		for (const auto& m : metrics) {
+			const Sketch& s = *m.second;
+			if (s.count == 0)
+				continue;
+			std::cout << pair.first << "\t" << m.first << "\t" << s.count << "\t"
+				  << format_duration(s.quantile(0.5)) << "\t" << format_duration(s.quantile(0.9))
+				  << "\t" << format_duration(s.quantile(0.99)) << "\n";
+		}
+	}
+}
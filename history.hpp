@@ -0,0 +1,39 @@
+#pragma once
+
+#include "parser.hpp"
+#include "task.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * append-only binary log at <data dir>/history.bin. after a 4-byte magic, each record is
+ *   int64 unix time, uint64 file id, uint8 event, uint8 priority, uint16 name length, name bytes
+ * in host byte order. the log is shared by all task files; the file id (a hash of the task
+ * file's canonical path) keeps same-named tasks in different files apart.
+ */
+enum class HistoryEvent : uint8_t { Ready = 0, Start = 1, Complete = 2 };
+
+struct HistoryRecord {
+	int64_t time = 0;
+	uint64_t file = 0;
+	HistoryEvent event = HistoryEvent::Complete;
+	Priority priority = Priority::Med;
+	std::string name;
+};
+
+std::string get_history_path();
+uint64_t history_file_id(const std::string& path);
+bool append_history(const std::vector<HistoryRecord>& records);
+bool read_history(const std::function<void(const HistoryRecord&)>& visit);
+
+void record_start(const TaskFile& tf, const std::string& name);
+void record_completion(const TaskFile& tf, const std::string& name);
+
+/* mean start -> complete time per task name in tf, for simulate */
+std::unordered_map<std::string, double> observed_durations(const TaskFile& tf);
+
+void print_stats(const TaskFile& tf, const std::string& by);
@@ -2,10 +2,50 @@
 #include "config.hpp"
 #include "parser.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <string>
 #include <vector>
 
+/* options that consume the following argument */
+static bool takes_value(const std::string& opt) {
+	return opt == "--where" || opt == "--tag" || opt == "--workers" || opt == "--default" ||
+	       opt == "--by";
+}
+
+/* only graph (colors, direction) and edit (editor) read the config file */
+static bool needs_config(const std::string& command) {
+	return command == "graph" || command == "edit";
+}
+
+/* --print-timing: microseconds spent in each startup phase, reported on stderr */
+struct Timing {
+	bool enabled = false;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), last = start;
+	std::string report;
+
+	void mark(const char* phase) {
+		if (!enabled)
+			return;
+		auto now = std::chrono::steady_clock::now();
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - last).count();
+		report += std::string(report.empty() ? "" : ", ") + phase + " " + std::to_string(us) + "us";
+		last = now;
+	}
+
+	void print() {
+		if (!enabled)
+			return;
+		auto total = std::chrono::duration_cast<std::chrono::microseconds>(last - start).count();
+		std::cerr << "timing: " << report << ", total " << total << "us\n";
+	}
+};
+
 int main(int argc, char** argv) {
+	std::ios::sync_with_stdio(false);
+
+	Timing timing;
 	std::string file_hint;
 	std::string command = "next";
 	std::vector<std::string> command_args;
@@ -13,7 +53,8 @@ int main(int argc, char** argv) {
 	for (int i = 1; i < argc; i++) {
 		std::string arg = argv[i];
 		if (arg == "next" || arg == "list" || arg == "complete" || arg == "block" || arg == "graph" ||
-		    arg == "edit" || arg == "help" || arg == "done" || arg == "add") {
+		    arg == "edit" || arg == "help" || arg == "done" || arg == "add" || arg == "levels" ||
+		    arg == "simulate" || arg == "start" || arg == "stats" || arg == "diff") {
 			command = arg;
 			/* collect remaining arguments for commands that need them */
 			if (command == "add") {
@@ -24,8 +65,15 @@ int main(int argc, char** argv) {
 			}
 		} else if (arg == "-h" || arg == "--help") {
 			command = "help";
-		} else if (command == "add") {
-			/* collecting args for add command */
+		} else if (arg == "--print-timing") {
+			timing.enabled = true;
+		} else if (arg.rfind("--", 0) == 0) {
+			/* command options, e.g. --where EXPR, are checked by run_command */
+			command_args.push_back(arg);
+			if (takes_value(arg) && i + 1 < argc)
+				command_args.push_back(argv[++i]);
+		} else if (command == "add" || command == "diff") {
+			/* collecting args for add, and the two files for diff */
 			command_args.push_back(arg);
 		} else {
 			file_hint = arg;
@@ -37,19 +85,43 @@ int main(int argc, char** argv) {
 		return 0;
 	}
 
-	Config config = load_config();
-	std::string filepath = find_file(file_hint);
+	timing.mark("args");
+	Config config;
+	if (needs_config(command))
+		config = load_config();
+	timing.mark("config");
+	/* diff names both of its files */
+	std::string filepath = command == "diff" ? "" : find_file(file_hint);
+	timing.mark("find");
 
-	if (command == "edit") {
+	/* next --stream reads the file itself, keeping only pending tasks */
+	bool stream = std::find(command_args.begin(), command_args.end(), "--stream") != command_args.end();
+	if (command == "edit" || command == "diff" || (command == "next" && stream)) {
 		TaskFile tf; // dummy, not used
-		return run_command(tf, command, config, filepath, command_args);
+		int status = run_command(tf, command, config, filepath, command_args);
+		std::cout.flush();
+		timing.mark("command");
+		timing.print();
+		return status;
 	}
 
 	TaskFile tf;
-	if (!tf.load(filepath))
+	bool loaded = tf.load(filepath);
+	timing.mark("load");
+	if (!loaded) {
+		timing.print();
 		return 1;
-	if (!tf.validate())
+	}
+	bool valid = tf.validate();
+	timing.mark("validate");
+	if (!valid) {
+		timing.print();
 		return 1;
+	}
 
-	return run_command(tf, command, config, filepath, command_args);
+	int status = run_command(tf, command, config, filepath, command_args);
+	std::cout.flush();
+	timing.mark("command");
+	timing.print();
+	return status;
 }
@@ -0,0 +1,18 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+size_t scan_threads(size_t n) {
+	const size_t min_per_thread = 16384;
+
+	size_t threads = std::thread::hardware_concurrency();
+	const char* env = std::getenv("TASKDAG_THREADS");
+	if (env) {
+		long requested = std::strtol(env, nullptr, 10);
+		if (requested >= 1)
+			threads = static_cast<size_t>(requested);
+	}
+
+	return std::max<size_t>(1, std::min(threads, n / min_per_thread));
+}
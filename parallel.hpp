@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+/*
+ * threads to use for a scan over n items: $TASKDAG_THREADS if set, else the hardware
+ * concurrency, but never so many that a thread gets less than a few thousand items.
+ */
+size_t scan_threads(size_t n);
+
+/*
+ * runs fn(i, out) for every i in [0, n), splitting the range into one contiguous chunk per
+ * thread with its own output buffer. buffers are concatenated in chunk order, so the result
+ * is exactly what a serial loop would produce.
+ */
+template <typename T, typename Fn>
+std::vector<T> parallel_collect(size_t n, Fn fn) {
+	size_t threads = scan_threads(n);
+	std::vector<T> out;
+	if (threads <= 1) {
+		for (size_t i = 0; i < n; i++)
+			fn(i, out);
+		return out;
+	}
+
+	std::vector<std::vector<T>> parts(threads);
+	std::vector<std::thread> pool;
+	size_t chunk = (n + threads - 1) / threads;
+	for (size_t t = 0; t < threads; t++) {
+		pool.emplace_back([&, t] {
+			size_t end = std::min(n, (t + 1) * chunk);
+			for (size_t i = t * chunk; i < end; i++)
+				fn(i, parts[t]);
+		});
+	}
+	for (auto& th : pool)
+		th.join();
+
+	size_t total = 0;
+	for (const auto& part : parts)
+		total += part.size();
+	out.reserve(total);
+	for (auto& part : parts)
+		out.insert(out.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+	return out;
+}
@@ -1,15 +1,23 @@
 #include "parser.hpp"
 
 #include "config.hpp"
+#include "parallel.hpp"
 #include "util.hpp"
 
 #include <algorithm>
+#include <cctype>
 #include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <queue>
 #include <set>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
 
 static std::string priority_to_string(Priority p) {
 	switch (p) {
@@ -24,6 +32,167 @@ static std::string priority_to_string(Priority p) {
 	}
 }
 
+/* "#infra": a letter first, so "#123" stays part of a name */
+static bool is_tag_token(const std::string& tok) {
+	if (tok.size() < 2 || tok[0] != '#' || !std::isalpha(static_cast<unsigned char>(tok[1])))
+		return false;
+	for (size_t i = 2; i < tok.size(); i++) {
+		char c = tok[i];
+		if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.' && c != '/')
+			return false;
+	}
+	return true;
+}
+
+/* "sprint:12": a word key starting with a letter and a non-empty value that isn't a url */
+static bool is_annotation_token(const std::string& tok, size_t& colon) {
+	colon = tok.find(':');
+	if (colon == std::string::npos || colon == 0 || colon + 1 >= tok.size())
+		return false;
+	if (!std::isalpha(static_cast<unsigned char>(tok[0])))
+		return false;
+	for (size_t i = 1; i < colon; i++) {
+		char c = tok[i];
+		if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+			return false;
+	}
+	return tok.find("//", colon) == std::string::npos;
+}
+
+static bool is_priority_token(const std::string& tok) {
+	static const char* names[] = {"!high", "!High", "!HIGH", "!med", "!Med", "!MED", "!low", "!Low", "!LOW"};
+	return std::find(std::begin(names), std::end(names), tok) != std::end(names);
+}
+
+/*
+ * pull the trailing block of "#tag" and "key:value" words (optionally mixed with the priority)
+ * off the name part. the first word always stays in the name, and words before the block are
+ * left alone, so names like "fix issue #123" or "read http://x" keep their text.
+ */
+static void extract_annotations(std::string& name_part, std::vector<std::string>& tags,
+				std::map<std::string, std::string>& annotations) {
+	std::vector<std::string> found_tags;
+	std::string priority_tok;
+	size_t end = name_part.find_last_not_of(" \t");
+	while (end != std::string::npos) {
+		size_t start = name_part.find_last_of(" \t", end);
+		if (start == std::string::npos)
+			break; /* first word */
+		std::string tok = name_part.substr(start + 1, end - start);
+
+		size_t colon;
+		if (is_tag_token(tok)) {
+			found_tags.push_back(tok.substr(1));
+		} else if (is_annotation_token(tok, colon)) {
+			/* rightmost value wins, as if read left to right */
+			annotations.emplace(tok.substr(0, colon), tok.substr(colon + 1));
+		} else if (is_priority_token(tok)) {
+			if (priority_tok.empty())
+				priority_tok = tok;
+		} else {
+			break;
+		}
+		name_part.erase(start);
+		end = name_part.find_last_not_of(" \t");
+	}
+
+	for (auto it = found_tags.rbegin(); it != found_tags.rend(); ++it) {
+		if (std::find(tags.begin(), tags.end(), *it) == tags.end())
+			tags.push_back(*it);
+	}
+	name_part = trim(name_part);
+	if (!priority_tok.empty())
+		name_part += " " + priority_tok;
+}
+
+/* parse one task line into t; false for blank lines, comments and malformed lines (with a warning) */
+static bool parse_task_line(const std::string& line, int line_num, Task& t) {
+	std::string trimmed = trim(line);
+	if (trimmed.empty() || trimmed[0] == '#')
+		return false;
+
+	/* parse: [x] or [ ] prefix */
+	bool completed = false;
+	std::string rest;
+
+	if (trimmed.size() >= 3 && trimmed[0] == '[' && trimmed[2] == ']') {
+		completed = (trimmed[1] == 'x' || trimmed[1] == 'X');
+		rest = trim(trimmed.substr(3));
+	} else {
+		std::cerr << "warning: line " << line_num << ": expected [ ] or [x] prefix\n";
+		return false;
+	}
+
+	/* parse: name -> dep1, dep2 */
+	std::string name;
+	std::vector<std::string> deps;
+	Priority priority = Priority::Med;
+
+	size_t arrow = rest.find("->");
+	std::string name_part;
+	if (arrow != std::string::npos) {
+		name_part = trim(rest.substr(0, arrow));
+		std::string dep_str = rest.substr(arrow + 2);
+		deps = split(dep_str, ',');
+		/* strip dep names the same way as the name, so "-> deploy to prod:eu" still finds its task */
+		for (auto& dep : deps) {
+			std::vector<std::string> dep_tags;
+			std::map<std::string, std::string> dep_annotations;
+			extract_annotations(dep, dep_tags, dep_annotations);
+		}
+	} else {
+		name_part = rest;
+	}
+
+	/* parse tags and annotations: #infra, sprint:12 */
+	std::vector<std::string> tags;
+	std::map<std::string, std::string> annotations;
+	extract_annotations(name_part, tags, annotations);
+
+	/* parse priority: !high, !med, !low */
+	std::string priority_str;
+	size_t priority_pos = name_part.find_last_of('!');
+	if (priority_pos != std::string::npos && priority_pos < name_part.length() - 1) {
+		std::string after_bang = trim(name_part.substr(priority_pos + 1));
+		/* check if it's a valid priority before a space or end */
+		size_t space_pos = after_bang.find(' ');
+		std::string potential_priority =
+		    space_pos != std::string::npos ? after_bang.substr(0, space_pos) : after_bang;
+
+		if (potential_priority == "high" || potential_priority == "High" ||
+		    potential_priority == "HIGH") {
+			priority = Priority::High;
+			name = trim(name_part.substr(0, priority_pos));
+		} else if (potential_priority == "med" || potential_priority == "Med" ||
+			   potential_priority == "MED") {
+			priority = Priority::Med;
+			name = trim(name_part.substr(0, priority_pos));
+		} else if (potential_priority == "low" || potential_priority == "Low" ||
+			   potential_priority == "LOW") {
+			priority = Priority::Low;
+			name = trim(name_part.substr(0, priority_pos));
+		} else {
+			name = name_part;
+		}
+	} else {
+		name = name_part;
+	}
+
+	if (name.empty()) {
+		std::cerr << "warning: line " << line_num << ": empty task name\n";
+		return false;
+	}
+
+	t.name = name;
+	t.completed = completed;
+	t.deps = deps;
+	t.priority = priority;
+	t.line_num = line_num;
+	t.tags = tags;
+	t.annotations = annotations;
+	return true;
+}
+
 bool TaskFile::load(const std::string& filepath) {
 	path = filepath;
 	std::ifstream f(filepath);
@@ -38,85 +207,165 @@ bool TaskFile::load(const std::string& filepath) {
 		lines.push_back(line);
 		line_num++;
 
-		std::string trimmed = trim(line);
-		if (trimmed.empty() || trimmed[0] == '#')
+		Task t;
+		if (!parse_task_line(line, line_num, t))
 			continue;
+		const std::string& name = t.name;
 
-		/* parse: [x] or [ ] prefix */
-		bool completed = false;
-		std::string rest;
-
-		if (trimmed.size() >= 3 && trimmed[0] == '[' && trimmed[2] == ']') {
-			completed = (trimmed[1] == 'x' || trimmed[1] == 'X');
-			rest = trim(trimmed.substr(3));
-		} else {
-			std::cerr << "warning: line " << line_num << ": expected [ ] or [x] prefix\n";
+		if (tasks.count(name)) {
+			std::cerr << "warning: line " << line_num << ": duplicate task '" << name << "'\n";
 			continue;
 		}
 
-		/* parse: name -> dep1, dep2 */
+		t.id = by_id.size();
+		Task& stored = tasks[name] = t;
+		by_id.push_back(&stored);
+
+		for (const auto& tag : stored.tags)
+			tag_index[tag].push_back(stored.id);
+		for (const auto& kv : stored.annotations)
+			tag_index[kv.first + ":" + kv.second].push_back(stored.id);
+	}
+
+	/* build the scan columns, resolving dep names to ids; unknown names are reported by validate() */
+	size_t n = by_id.size();
+	cols.done.resize(n);
+	cols.priority.resize(n);
+	cols.line_num.resize(n);
+	cols.name_rank.resize(n);
+	cols.dep_offset.assign(1, 0);
+	for (size_t id = 0; id < n; id++) {
+		const Task* t = by_id[id];
+		cols.done[id] = t->completed;
+		cols.priority[id] = static_cast<uint8_t>(t->priority);
+		cols.line_num[id] = t->line_num;
+		for (const auto& dep : t->deps) {
+			auto it = tasks.find(dep);
+			if (it != tasks.end())
+				cols.dep_ids.push_back(static_cast<uint32_t>(it->second.id));
+		}
+		cols.dep_offset.push_back(cols.dep_ids.size());
+	}
+	uint32_t rank = 0;
+	for (const auto& pair : tasks)
+		cols.name_rank[pair.second.id] = rank++;
+
+	return true;
+}
+
+bool stream_next(const std::string& filepath, std::vector<std::string>& actionable) {
+	std::ifstream f(filepath);
+	if (!f) {
+		std::cerr << "error: cannot open " << filepath << "\n";
+		return false;
+	}
+
+	/*
+	 * only pending tasks are kept. a dep blocks a task iff it names another pending task: completed
+	 * and unknown deps never do, matching get_next(). deque keeps names in place for the views.
+	 */
+	struct Pending {
 		std::string name;
 		std::vector<std::string> deps;
-		Priority priority = Priority::Med;
-
-		size_t arrow = rest.find("->");
-		std::string name_part;
-		if (arrow != std::string::npos) {
-			name_part = trim(rest.substr(0, arrow));
-			std::string dep_str = rest.substr(arrow + 2);
-			deps = split(dep_str, ',');
-		} else {
-			name_part = rest;
-		}
-
-		/* parse priority: !high, !med, !low */
-		std::string priority_str;
-		size_t priority_pos = name_part.find_last_of('!');
-		if (priority_pos != std::string::npos && priority_pos < name_part.length() - 1) {
-			std::string after_bang = trim(name_part.substr(priority_pos + 1));
-			/* check if it's a valid priority before a space or end */
-			size_t space_pos = after_bang.find(' ');
-			std::string potential_priority =
-			    space_pos != std::string::npos ? after_bang.substr(0, space_pos) : after_bang;
-
-			if (potential_priority == "high" || potential_priority == "High" ||
-			    potential_priority == "HIGH") {
-				priority = Priority::High;
-				name = trim(name_part.substr(0, priority_pos));
-			} else if (potential_priority == "med" || potential_priority == "Med" ||
-				   potential_priority == "MED") {
-				priority = Priority::Med;
-				name = trim(name_part.substr(0, priority_pos));
-			} else if (potential_priority == "low" || potential_priority == "Low" ||
-				   potential_priority == "LOW") {
-				priority = Priority::Low;
-				name = trim(name_part.substr(0, priority_pos));
-			} else {
-				name = name_part;
-			}
-		} else {
-			name = name_part;
-		}
+		Priority priority;
+		int line_num;
+		bool dropped = false;
+	};
+	std::deque<Pending> pending;
+	std::unordered_map<std::string_view, Pending*> pending_names;
+
+	std::string line;
+	int line_num = 0;
+	while (std::getline(f, line)) {
+		line_num++;
 
-		if (name.empty()) {
-			std::cerr << "warning: line " << line_num << ": empty task name\n";
+		/* completed tasks can never be actionable or blocking, so skip them unparsed */
+		size_t start = line.find_first_not_of(" \t");
+		if (start != std::string::npos && line.compare(start, 3, "[x]") == 0)
+			continue;
+		if (start != std::string::npos && line.compare(start, 3, "[X]") == 0)
 			continue;
-		}
 
-		if (tasks.count(name)) {
-			std::cerr << "warning: line " << line_num << ": duplicate task '" << name << "'\n";
+		Task t;
+		if (!parse_task_line(line, line_num, t))
+			continue;
+		if (pending_names.count(t.name)) {
+			std::cerr << "warning: line " << line_num << ": duplicate task '" << t.name << "'\n";
 			continue;
 		}
+		pending.push_back({std::move(t.name), std::move(t.deps), t.priority, line_num});
+		pending_names.emplace(pending.back().name, &pending.back());
+	}
 
-		Task t;
-		t.name = name;
-		t.completed = completed;
-		t.deps = deps;
-		t.priority = priority;
-		t.line_num = line_num;
-		tasks[name] = t;
+	/* does the name part of a completed line start with a pending name, up to a word boundary? */
+	auto may_name_pending = [&](const std::string& line, size_t from) {
+		size_t begin = line.find_first_not_of(" \t", from);
+		if (begin == std::string::npos)
+			return false;
+		std::string_view rest = std::string_view(line).substr(begin);
+		for (size_t i = 1; i <= rest.size(); i++) {
+			if (i < rest.size() && rest[i] != ' ' && rest[i] != '\t' && rest[i] != '!' && rest[i] != '-')
+				continue;
+			if (rest[i - 1] != ' ' && rest[i - 1] != '\t' && pending_names.count(rest.substr(0, i)))
+				return true;
+		}
+		return false;
+	};
+
+	/*
+	 * load() keeps the first of two same-named tasks, so a pending task named like an earlier
+	 * completed one is a duplicate that is done, not actionable. a second pass looks for those,
+	 * parsing only completed lines whose text starts with a pending name.
+	 */
+	if (!pending.empty()) {
+		f.clear();
+		f.seekg(0);
+		line_num = 0;
+		while (std::getline(f, line)) {
+			line_num++;
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos ||
+			    (line.compare(start, 3, "[x]") != 0 && line.compare(start, 3, "[X]") != 0))
+				continue;
+			if (!may_name_pending(line, start + 3))
+				continue;
+
+			Task t;
+			if (!parse_task_line(line, line_num, t))
+				continue;
+			auto it = pending_names.find(t.name);
+			if (it == pending_names.end())
+				continue;
+			Pending* p = it->second;
+			if (p->line_num < line_num) {
+				std::cerr << "warning: line " << line_num << ": duplicate task '" << t.name << "'\n";
+				continue;
+			}
+			std::cerr << "warning: line " << p->line_num << ": duplicate task '" << p->name << "'\n";
+			p->dropped = true;
+			pending_names.erase(it);
+		}
+	}
+
+	std::vector<const Pending*> ready;
+	for (const auto& p : pending) {
+		if (p.dropped)
+			continue;
+		bool blocked = std::any_of(p.deps.begin(), p.deps.end(),
+					   [&](const std::string& dep) { return pending_names.count(dep) > 0; });
+		if (!blocked)
+			ready.push_back(&p);
 	}
 
+	/* sort by priority first (High > Med > Low), second by line num */
+	std::sort(ready.begin(), ready.end(), [](const Pending* a, const Pending* b) {
+		if (a->priority != b->priority)
+			return static_cast<int>(a->priority) > static_cast<int>(b->priority);
+		return a->line_num < b->line_num;
+	});
+
+	for (const Pending* p : ready)
+		actionable.push_back(p->name);
 	return true;
 }
 
@@ -134,17 +383,37 @@ bool TaskFile::save() {
 
 bool TaskFile::validate() {
 	bool valid = true;
-	for (const auto& pair : tasks) {
-		const std::string& name = pair.first;
-		const Task& task = pair.second;
+
+	/*
+	 * unknown deps, reported in name order. a task whose deps all resolved at load has nothing to
+	 * look up, so only the rest touch the name map; the scan is split across threads.
+	 */
+	size_t n = by_id.size();
+	std::vector<size_t> by_name(n);
+	for (size_t id = 0; id < n; id++)
+		by_name[cols.name_rank[id]] = id;
+
+	auto check = [&](size_t i, std::vector<std::string>& out) {
+		size_t id = by_name[i];
+		const Task& task = *by_id[id];
+		if (cols.dep_offset[id + 1] - cols.dep_offset[id] == task.deps.size())
+			return;
 		for (const auto& dep : task.deps) {
-			if (!tasks.count(dep)) {
-				std::cerr << "error: task '" << name << "' depends on unknown task '" << dep << "'\n";
-				valid = false;
-			}
+			if (!tasks.count(dep))
+				out.push_back("error: task '" + task.name + "' depends on unknown task '" + dep +
+					      "'\n");
 		}
+	};
+	for (const auto& e : parallel_collect<std::string>(n, check)) {
+		std::cerr << e;
+		valid = false;
 	}
 
+	/* an acyclic graph puts every task on a level, so the cycle search below only runs when needed */
+	std::vector<int> level = get_levels(false);
+	if (std::find(level.begin(), level.end(), -1) == level.end())
+		return valid;
+
 	std::set<std::string> visited, in_stack;
 	std::vector<std::string> cycle_path;
 
@@ -191,41 +460,160 @@ bool TaskFile::validate() {
 	return valid;
 }
 
-std::vector<std::string> TaskFile::get_next() {
-	std::vector<std::string> actionable;
-	for (const auto& pair : tasks) {
-		const std::string& name = pair.first;
-		const Task& task = pair.second;
-		if (task.completed)
+static bool has_pending_dep(const TaskColumns& cols, size_t id) {
+	for (size_t k = cols.dep_offset[id]; k < cols.dep_offset[id + 1]; k++) {
+		if (!cols.done[cols.dep_ids[k]])
+			return true;
+	}
+	return false;
+}
+
+/* sort by priority first (High > Med > Low), second by line num */
+static bool sorts_before(const TaskColumns& cols, size_t a, size_t b) {
+	if (cols.priority[a] != cols.priority[b])
+		return cols.priority[a] > cols.priority[b];
+	return cols.line_num[a] < cols.line_num[b];
+}
+
+std::vector<size_t> TaskFile::tagged(const std::vector<std::string>& tags) const {
+	/* intersect the posting lists; ids are already sorted in file order */
+	std::vector<size_t> ids;
+	for (size_t i = 0; i < tags.size(); i++) {
+		auto it = tag_index.find(tags[i]);
+		if (it == tag_index.end())
+			return {};
+		if (i == 0) {
+			ids = it->second;
 			continue;
+		}
+		std::vector<size_t> both;
+		std::set_intersection(ids.begin(), ids.end(), it->second.begin(), it->second.end(),
+				      std::back_inserter(both));
+		ids.swap(both);
+	}
+	return ids;
+}
 
-		bool blocked = false;
-		for (const auto& dep : task.deps) {
-			if (tasks.count(dep) && !tasks.at(dep).completed) {
-				blocked = true;
-				break;
+/* ids allowed by the filter's --tag restrictions for which keep(id) holds, in file order */
+template <typename Keep>
+static std::vector<size_t> select_ids(const TaskFile& tf, const Filter* filter, Keep keep) {
+	std::vector<size_t> tagged;
+	bool use_tags = filter && !filter->tags.empty();
+	if (use_tags)
+		tagged = tf.tagged(filter->tags);
+
+	size_t n = use_tags ? tagged.size() : tf.by_id.size();
+	return parallel_collect<size_t>(n, [&](size_t i, std::vector<size_t>& out) {
+		size_t id = use_tags ? tagged[i] : i;
+		if (keep(id))
+			out.push_back(id);
+	});
+}
+
+static bool filter_keeps(const Filter* filter, const TaskFile& tf, size_t id, const std::vector<int>& depths) {
+	if (!filter)
+		return true;
+	return filter->matches(*tf.by_id[id], depths.empty() ? 0 : depths[id]);
+}
+
+/*
+ * dependents in CSR form: the tasks that depend on id are dependents[offset[id] .. offset[id + 1]).
+ * indegree counts each task's deps. with unfinished_only, completed tasks and edges to them are left out.
+ */
+static void build_dependents(const TaskColumns& cols, bool unfinished_only, std::vector<size_t>& offset,
+			     std::vector<size_t>& dependents, std::vector<size_t>& indegree) {
+	size_t n = cols.done.size();
+	auto included = [&](size_t id) { return !unfinished_only || !cols.done[id]; };
+
+	indegree.assign(n, 0);
+	offset.assign(n + 1, 0);
+	for (size_t id = 0; id < n; id++) {
+		if (!included(id))
+			continue;
+		for (size_t k = cols.dep_offset[id]; k < cols.dep_offset[id + 1]; k++) {
+			size_t dep = cols.dep_ids[k];
+			if (included(dep)) {
+				indegree[id]++;
+				offset[dep + 1]++;
 			}
 		}
+	}
+	for (size_t id = 0; id < n; id++)
+		offset[id + 1] += offset[id];
+
+	dependents.assign(offset[n], 0);
+	std::vector<size_t> cursor(offset.begin(), offset.end() - 1);
+	for (size_t id = 0; id < n; id++) {
+		if (!included(id))
+			continue;
+		for (size_t k = cols.dep_offset[id]; k < cols.dep_offset[id + 1]; k++) {
+			size_t dep = cols.dep_ids[k];
+			if (included(dep))
+				dependents[cursor[dep]++] = id;
+		}
+	}
+}
+
+std::vector<int> TaskFile::get_levels(bool unfinished_only) const {
+	/*
+	 * kahn's algorithm over resolved ids: a task's level is the longest dependency chain below it.
+	 * linear in tasks + edges. tasks left out (or stuck on a cycle) get -1.
+	 */
+	size_t n = cols.done.size();
+	auto included = [&](size_t id) { return !unfinished_only || !cols.done[id]; };
 
-		if (!blocked) {
-			actionable.push_back(name);
+	std::vector<size_t> offset, dependents, indegree;
+	build_dependents(cols, unfinished_only, offset, dependents, indegree);
+
+	std::vector<int> level(n, -1);
+	std::vector<size_t> queue;
+	queue.reserve(n);
+	for (size_t id = 0; id < n; id++) {
+		if (included(id) && indegree[id] == 0) {
+			level[id] = 0;
+			queue.push_back(id);
 		}
 	}
 
-	std::sort(actionable.begin(), actionable.end(), [this](const std::string& a, const std::string& b) {
-		const Task& task_a = tasks.at(a);
-		const Task& task_b = tasks.at(b);
-		/* sort by priority first (High > Med > Low) */
-		if (task_a.priority != task_b.priority) {
-			return static_cast<int>(task_a.priority) > static_cast<int>(task_b.priority);
+	for (size_t i = 0; i < queue.size(); i++) {
+		size_t id = queue[i];
+		for (size_t k = offset[id]; k < offset[id + 1]; k++) {
+			size_t d = dependents[k];
+			level[d] = std::max(level[d], level[id] + 1);
+			if (--indegree[d] == 0)
+				queue.push_back(d);
 		}
-		/* second by line num */
-		return task_a.line_num < task_b.line_num;
+	}
+
+	return level;
+}
+
+/* pending tasks whose deps are all done and that the filter keeps, in no particular order */
+static std::vector<size_t> select_ready(const TaskFile& tf, const Filter* filter) {
+	std::vector<int> depths;
+	if (filter && filter->uses_depth)
+		depths = tf.get_levels(false);
+
+	return select_ids(tf, filter, [&](size_t id) {
+		return !tf.cols.done[id] && !has_pending_dep(tf.cols, id) && filter_keeps(filter, tf, id, depths);
 	});
+}
+
+std::vector<std::string> TaskFile::get_next(const Filter* filter) {
+	std::vector<size_t> ready = select_ready(*this, filter);
+	std::sort(ready.begin(), ready.end(), [this](size_t a, size_t b) { return sorts_before(cols, a, b); });
 
+	std::vector<std::string> actionable;
+	actionable.reserve(ready.size());
+	for (size_t id : ready)
+		actionable.push_back(by_id[id]->name);
 	return actionable;
 }
 
+size_t TaskFile::count_next(const Filter* filter) {
+	return select_ready(*this, filter).size();
+}
+
 const Task& TaskFile::get_task(const std::string& name) const {
 	return tasks.at(name);
 }
@@ -248,6 +636,7 @@ bool TaskFile::complete(const std::string& name) {
 	if (bracket != std::string::npos) {
 		line[bracket + 1] = 'x';
 		task.completed = true;
+		cols.done[task.id] = true;
 		return save();
 	}
 
@@ -255,22 +644,29 @@ bool TaskFile::complete(const std::string& name) {
 	return false;
 }
 
-void TaskFile::print_list() {
-	std::vector<const Task*> sorted;
-	for (const auto& pair : tasks) {
-		sorted.push_back(&pair.second);
+void TaskFile::print_list(const Filter* filter, bool count_only) {
+	std::vector<int> depths;
+	if (filter && filter->uses_depth)
+		depths = get_levels(false);
+
+	std::vector<size_t> sorted =
+	    select_ids(*this, filter, [&](size_t id) { return filter_keeps(filter, *this, id, depths); });
+	if (count_only) {
+		std::cout << sorted.size() << "\n";
+		return;
 	}
-	std::sort(sorted.begin(), sorted.end(), [](const Task* a, const Task* b) {
-		/* sort by priority first (High > Med > Low) */
-		if (a->priority != b->priority) {
-			return static_cast<int>(a->priority) > static_cast<int>(b->priority);
-		}
-		/* second by line num */
-		return a->line_num < b->line_num;
-	});
 
-	for (const Task* t : sorted) {
+	std::sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) { return sorts_before(cols, a, b); });
+
+	for (size_t id : sorted) {
+		const Task* t = by_id[id];
 		std::cout << (t->completed ? "[x] " : "[ ] ") << t->name;
+		for (const auto& tag : t->tags) {
+			std::cout << " #" << tag;
+		}
+		for (const auto& kv : t->annotations) {
+			std::cout << " " << kv.first << ":" << kv.second;
+		}
 		if (t->priority != Priority::Med) {
 			std::cout << " " << priority_to_string(t->priority);
 		}
@@ -286,32 +682,297 @@ void TaskFile::print_list() {
 	}
 }
 
-void TaskFile::print_blocked() {
-	for (const auto& pair : tasks) {
-		const std::string& name = pair.first;
-		const Task& task = pair.second;
-		if (task.completed)
+void TaskFile::print_blocked(const Filter* filter, bool count_only) {
+	std::vector<int> depths;
+	if (filter && filter->uses_depth)
+		depths = get_levels(false);
+
+	std::vector<size_t> blocked = select_ids(*this, filter, [&](size_t id) {
+		return !cols.done[id] && has_pending_dep(cols, id) && filter_keeps(filter, *this, id, depths);
+	});
+	if (count_only) {
+		std::cout << blocked.size() << "\n";
+		return;
+	}
+
+	/* blocked tasks are listed alphabetically */
+	std::sort(blocked.begin(), blocked.end(),
+		  [this](size_t a, size_t b) { return cols.name_rank[a] < cols.name_rank[b]; });
+
+	for (size_t id : blocked) {
+		const Task* task = by_id[id];
+		std::cout << task->name;
+		if (task->priority != Priority::Med) {
+			std::cout << " " << priority_to_string(task->priority);
+		}
+		std::cout << " blocked by: ";
+		bool first = true;
+		for (size_t k = cols.dep_offset[id]; k < cols.dep_offset[id + 1]; k++) {
+			size_t dep = cols.dep_ids[k];
+			if (cols.done[dep])
+				continue;
+			if (!first)
+				std::cout << ", ";
+			std::cout << by_id[dep]->name;
+			first = false;
+		}
+		std::cout << "\n";
+	}
+}
+
+void TaskFile::print_levels(bool unfinished_only, bool summary) {
+	std::vector<int> level = get_levels(unfinished_only);
+
+	int max_level = -1;
+	for (int l : level)
+		max_level = std::max(max_level, l);
+
+	/* bucket ids by level; ids are in file order, so each layer stays in file order too */
+	std::vector<std::vector<size_t>> layers(max_level + 1);
+	for (size_t id = 0; id < level.size(); id++) {
+		if (level[id] >= 0)
+			layers[level[id]].push_back(id);
+	}
+
+	size_t total = 0, widest = 0;
+	int widest_level = 0;
+	for (int l = 0; l <= max_level; l++) {
+		total += layers[l].size();
+		if (layers[l].size() > widest) {
+			widest = layers[l].size();
+			widest_level = l;
+		}
+	}
+
+	std::cout << "tasks: " << total << ", levels: " << layers.size() << "\n";
+	std::cout << "max parallelism: " << widest << " (level " << widest_level << ")\n\n";
+
+	/* width histogram, bars scaled to 50 columns */
+	const size_t bar_max = 50;
+	for (int l = 0; l <= max_level; l++) {
+		size_t width = layers[l].size();
+		size_t bar = widest ? (width * bar_max + widest - 1) / widest : 0;
+		std::cout << "level " << l << "\t" << std::string(bar, '#') << " " << width << "\n";
+	}
+
+	if (summary)
+		return;
+
+	for (int l = 0; l <= max_level; l++) {
+		std::vector<size_t>& ids = layers[l];
+		std::sort(ids.begin(), ids.end(), [this](size_t a, size_t b) { return sorts_before(cols, a, b); });
+		std::cout << "\nlevel " << l << " (" << ids.size() << "):\n";
+		for (size_t id : ids) {
+			const Task* t = by_id[id];
+			std::cout << "  " << t->name;
+			if (t->priority != Priority::Med) {
+				std::cout << " " << priority_to_string(t->priority);
+			}
+			std::cout << "\n";
+		}
+	}
+}
+
+void TaskFile::print_simulation(int workers, double default_duration,
+				const std::unordered_map<std::string, double>& observed) {
+	size_t n = by_id.size();
+	std::vector<size_t> offset, dependents, indegree;
+	build_dependents(cols, true, offset, dependents, indegree);
+
+	/* durations come from est: annotations, then observed history, then the default */
+	std::vector<double> duration(n, default_duration);
+	size_t pending = 0, estimated = 0, from_history = 0;
+	for (size_t id = 0; id < n; id++) {
+		const Task* t = by_id[id];
+		if (t->completed)
 			continue;
+		pending++;
+		auto it = t->annotations.find("est");
+		if (it != t->annotations.end()) {
+			if (parse_duration(it->second, duration[id])) {
+				estimated++;
+				continue;
+			}
+			std::cerr << "warning: line " << t->line_num << ": invalid duration 'est:" << it->second
+				  << "'\n";
+		}
+		auto seen = observed.find(t->name);
+		if (seen != observed.end()) {
+			duration[id] = seen->second;
+			from_history++;
+		}
+	}
 
-		std::vector<std::string> blocking;
-		for (const auto& dep : task.deps) {
-			if (tasks.count(dep) && !tasks.at(dep).completed) {
-				blocking.push_back(dep);
+	if (pending == 0) {
+		std::cout << "nothing to simulate: all tasks completed\n";
+		return;
+	}
+
+	/* ready tasks, best on top: priority first, then file order, as in get_next() */
+	auto worse = [this](size_t a, size_t b) { return sorts_before(cols, b, a); };
+	std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> ready(worse);
+
+	/* running tasks keyed by finish time */
+	using Event = std::pair<double, size_t>;
+	std::priority_queue<Event, std::vector<Event>, std::greater<Event>> running;
+
+	for (size_t id = 0; id < n; id++) {
+		if (!cols.done[id] && indegree[id] == 0)
+			ready.push(id);
+	}
+
+	double now = 0, busy = 0;
+	int free_workers = workers;
+	size_t finished = 0;
+	while (true) {
+		while (free_workers > 0 && !ready.empty()) {
+			size_t id = ready.top();
+			ready.pop();
+			running.push({now + duration[id], id});
+			busy += duration[id];
+			free_workers--;
+		}
+		if (running.empty())
+			break;
+
+		/* retire everything finishing at this instant before handing out more work */
+		now = running.top().first;
+		while (!running.empty() && running.top().first == now) {
+			size_t id = running.top().second;
+			running.pop();
+			free_workers++;
+			finished++;
+			for (size_t k = offset[id]; k < offset[id + 1]; k++) {
+				if (--indegree[dependents[k]] == 0)
+					ready.push(dependents[k]);
 			}
 		}
+	}
 
-		if (!blocking.empty()) {
-			std::cout << name;
-			if (task.priority != Priority::Med) {
-				std::cout << " " << priority_to_string(task.priority);
+	double capacity = now * workers;
+	std::cout << "tasks: " << pending << " (" << estimated << " with est:, " << from_history
+		  << " from history, others " << format_duration(default_duration) << " each)\n";
+	std::cout << "workers: " << workers << "\n";
+	std::cout << "makespan: " << format_duration(now) << "\n";
+	std::cout << "work: " << format_duration(busy) << "\n";
+	if (capacity > 0) {
+		std::cout << "utilization: " << std::fixed << std::setprecision(1) << 100.0 * busy / capacity << "%\n";
+	}
+	std::cout << "idle time: " << format_duration(capacity - busy) << "\n";
+	if (finished != pending) {
+		std::cerr << "warning: " << pending - finished << " tasks never became ready\n";
+	}
+}
+
+void print_diff(const TaskFile& before, const TaskFile& after) {
+	/* align tasks by name with a merge join over the two name-ordered maps */
+	struct Pair {
+		const Task* old_task;
+		const Task* new_task;
+		bool affected;
+	};
+	std::vector<Pair> pairs;
+	std::vector<size_t> pair_of_new(after.by_id.size());
+	std::vector<bool> flipped(after.by_id.size()); /* completion changed */
+	bool any_flipped = false;
+
+	auto same_deps = [](const Task& a, const Task& b) {
+		if (a.deps == b.deps)
+			return true;
+		std::set<std::string> x(a.deps.begin(), a.deps.end()), y(b.deps.begin(), b.deps.end());
+		return x == y;
+	};
+
+	auto o = before.tasks.begin(), n = after.tasks.begin();
+	while (o != before.tasks.end() || n != after.tasks.end()) {
+		if (n == after.tasks.end() || (o != before.tasks.end() && o->first < n->first)) {
+			pairs.push_back({&o->second, nullptr, true});
+			++o;
+		} else if (o == before.tasks.end() || n->first < o->first) {
+			pair_of_new[n->second.id] = pairs.size();
+			pairs.push_back({nullptr, &n->second, true});
+			++n;
+		} else {
+			const Task& a = o->second;
+			const Task& b = n->second;
+			pair_of_new[b.id] = pairs.size();
+			pairs.push_back({&a, &b, a.completed != b.completed || !same_deps(a, b)});
+			if (a.completed != b.completed) {
+				flipped[b.id] = true;
+				any_flipped = true;
 			}
-			std::cout << " blocked by: ";
-			for (size_t i = 0; i < blocking.size(); i++) {
-				if (i > 0)
-					std::cout << ", ";
-				std::cout << blocking[i];
+			++o;
+			++n;
+		}
+	}
+
+	/*
+	 * a task's readiness depends only on itself and its direct deps, so besides the changed tasks
+	 * only direct dependents of tasks whose completion flipped need rechecking.
+	 */
+	const TaskColumns& cols = after.cols;
+	if (any_flipped) {
+		for (size_t id = 0; id < after.by_id.size(); id++) {
+			for (size_t k = cols.dep_offset[id]; k < cols.dep_offset[id + 1]; k++) {
+				if (flipped[cols.dep_ids[k]]) {
+					pairs[pair_of_new[id]].affected = true;
+					break;
+				}
 			}
-			std::cout << "\n";
+		}
+	}
+
+	auto ready = [](const TaskFile& tf, const Task* t) {
+		return t && !t->completed && !has_pending_dep(tf.cols, t->id);
+	};
+	auto blocked = [](const TaskFile& tf, const Task* t) {
+		return t && !t->completed && has_pending_dep(tf.cols, t->id);
+	};
+
+	std::vector<std::string> now_ready, not_ready, now_blocked, not_blocked, edges_added, edges_removed;
+	for (const Pair& p : pairs) {
+		if (!p.affected)
+			continue;
+		const std::string& name = p.new_task ? p.new_task->name : p.old_task->name;
+
+		bool was_ready = ready(before, p.old_task), is_ready = ready(after, p.new_task);
+		if (is_ready && !was_ready)
+			now_ready.push_back(name);
+		if (was_ready && !is_ready)
+			not_ready.push_back(name);
+
+		bool was_blocked = blocked(before, p.old_task), is_blocked = blocked(after, p.new_task);
+		if (is_blocked && !was_blocked)
+			now_blocked.push_back(name);
+		if (was_blocked && !is_blocked)
+			not_blocked.push_back(name);
+
+		std::set<std::string> old_deps, new_deps;
+		if (p.old_task)
+			old_deps.insert(p.old_task->deps.begin(), p.old_task->deps.end());
+		if (p.new_task)
+			new_deps.insert(p.new_task->deps.begin(), p.new_task->deps.end());
+		for (const auto& dep : new_deps) {
+			if (!old_deps.count(dep))
+				edges_added.push_back(dep + " -> " + name);
+		}
+		for (const auto& dep : old_deps) {
+			if (!new_deps.count(dep))
+				edges_removed.push_back(dep + " -> " + name);
+		}
+	}
+
+	const std::pair<const char*, const std::vector<std::string>*> sections[] = {
+	    {"+next", &now_ready},
+	    {"-next", &not_ready},
+	    {"+blocked", &now_blocked},
+	    {"-blocked", &not_blocked},
+	    {"+edge", &edges_added},
+	    {"-edge", &edges_removed},
+	};
+	for (const auto& section : sections) {
+		for (const auto& line : *section.second) {
+			std::cout << section.first << "\t" << line << "\n";
 		}
 	}
 }
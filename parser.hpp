@@ -1,9 +1,11 @@
 #pragma once
 
 #include "config.hpp"
+#include "filter.hpp"
 #include "task.hpp"
 
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
@@ -11,14 +13,36 @@ struct TaskFile {
 	std::string path;
 	std::vector<std::string> lines;
 	std::map<std::string, Task> tasks;
+	std::vector<Task*> by_id;
+	TaskColumns cols;
+	/* posting lists: "tag" or "key:value" -> ids of tasks carrying it, in file order */
+	std::map<std::string, std::vector<size_t>> tag_index;
 
 	bool load(const std::string& filepath);
 	bool save();
 	bool validate();
-	std::vector<std::string> get_next();
+	std::vector<std::string> get_next(const Filter* filter = nullptr);
+	size_t count_next(const Filter* filter = nullptr);
+	std::vector<int> get_levels(bool unfinished_only) const;
+	std::vector<size_t> tagged(const std::vector<std::string>& tags) const;
 	const Task& get_task(const std::string& name) const;
 	bool complete(const std::string& name);
-	void print_list();
-	void print_blocked();
+	void print_list(const Filter* filter = nullptr, bool count_only = false);
+	void print_blocked(const Filter* filter = nullptr, bool count_only = false);
+	void print_levels(bool unfinished_only, bool summary);
+	void print_simulation(int workers, double default_duration,
+			      const std::unordered_map<std::string, double>& observed);
 	void print_graph(const Config& config);
 };
+
+/*
+ * next without loading the graph: one pass over the file that keeps only pending tasks, so
+ * memory follows the number of pending tasks. skips validation (unknown deps, cycles).
+ */
+bool stream_next(const std::string& filepath, std::vector<std::string>& actionable);
+
+/*
+ * what changed between two versions of a file: tasks that became or stopped being actionable
+ * or blocked, and added/removed dependency edges. tasks are matched by name.
+ */
+void print_diff(const TaskFile& before, const TaskFile& after);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -11,4 +13,20 @@ struct Task {
 	std::vector<std::string> deps;
 	Priority priority = Priority::Med;
 	int line_num = 0;
+	size_t id = 0; /* position in file order, indexes TaskColumns and the tag index */
+	std::vector<std::string> tags;
+	std::map<std::string, std::string> annotations;
+};
+
+/*
+ * hot per-task fields stored as dense arrays indexed by Task::id, so that scans only touch
+ * these; names, dep names and annotations stay in Task and are read when printing.
+ */
+struct TaskColumns {
+	std::vector<bool> done;          /* completion bitset */
+	std::vector<uint8_t> priority;   /* Priority as a byte, higher is more urgent */
+	std::vector<int> line_num;
+	std::vector<uint32_t> name_rank; /* position in alphabetical order */
+	std::vector<size_t> dep_offset;  /* deps of id are dep_ids[dep_offset[id] .. dep_offset[id + 1]) */
+	std::vector<uint32_t> dep_ids;
 };
@@ -1,5 +1,7 @@
 #include "util.hpp"
 
+#include <cctype>
+#include <cmath>
 #include <sstream>
 
 std::string trim(const std::string& s) {
@@ -22,3 +24,90 @@ std::vector<std::string> split(const std::string& s, char delim) {
 	}
 	return parts;
 }
+
+bool parse_duration(const std::string& s, double& seconds) {
+	/* ten years; anything longer is a typo, and keeps sums of durations well inside range */
+	const double max_seconds = 10 * 365 * 86400.0;
+
+	if (s.empty())
+		return false;
+
+	double total = 0;
+	size_t i = 0;
+	while (i < s.size()) {
+		/* plain decimal only: digits with an optional fraction, no sign, exponent, hex, inf or nan */
+		size_t start = i;
+		double n = 0;
+		while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) {
+			n = n * 10 + (s[i] - '0');
+			i++;
+		}
+		size_t int_digits = i - start;
+		size_t frac_digits = 0;
+		if (i < s.size() && s[i] == '.') {
+			i++;
+			double scale = 0.1;
+			while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) {
+				n += (s[i] - '0') * scale;
+				scale /= 10;
+				frac_digits++;
+				i++;
+			}
+		}
+		if (int_digits + frac_digits == 0 || int_digits > 9)
+			return false;
+
+		double unit = 3600;
+		if (i < s.size()) {
+			switch (std::tolower(static_cast<unsigned char>(s[i]))) {
+				case 's':
+					unit = 1;
+					break;
+				case 'm':
+					unit = 60;
+					break;
+				case 'h':
+					unit = 3600;
+					break;
+				case 'd':
+					unit = 86400;
+					break;
+				case 'w':
+					unit = 7 * 86400;
+					break;
+				default:
+					return false;
+			}
+			i++;
+		} else if (start != 0) {
+			/* a bare number is hours only when it is the whole value: "30m1" is a typo */
+			return false;
+		}
+		total += n * unit;
+		if (total > max_seconds)
+			return false;
+	}
+
+	seconds = total;
+	return true;
+}
+
+std::string format_duration(double seconds) {
+	long long secs = std::llround(seconds);
+	if (secs < 60)
+		return std::to_string(secs) + "s";
+	secs = (secs + 30) / 60 * 60; /* nearest minute */
+
+	long long days = secs / 86400;
+	long long hours = secs % 86400 / 3600;
+	long long mins = secs % 3600 / 60;
+
+	std::string out;
+	if (days)
+		out += std::to_string(days) + "d";
+	if (hours)
+		out += (out.empty() ? "" : " ") + std::to_string(hours) + "h";
+	if (mins)
+		out += (out.empty() ? "" : " ") + std::to_string(mins) + "m";
+	return out;
+}
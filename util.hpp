@@ -6,3 +6,8 @@
 std::string trim(const std::string& s);
 
 std::vector<std::string> split(const std::string& s, char delim);
+
+/* durations like "45s", "30m", "1.5h", "2d", "1h30m", up to ten years; a bare number on its own is hours */
+bool parse_duration(const std::string& s, double& seconds);
+
+std::string format_duration(double seconds);